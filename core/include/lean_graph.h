@@ -1,15 +1,20 @@
 #pragma once
 #include <__expected/unexpected.h>
 #include <algorithm>
+#include <compare>
+#include <concepts>
 #include <functional>
 #include <limits>
+#include <numeric>
 #include <optional>
 #include <queue>
+#include <ranges>
 #include <set>
 #include <stack>
 #include <tuple>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 /////////////////////////////////////////////////////////////////
 /////////////////////////// START DECL SPACE
@@ -25,6 +30,27 @@ concept Hashable = requires(T a) {
   { std::hash<T>{}(a) } -> std::convertible_to<std::size_t>;
 };
 
+// TAG: Unweighted DECL
+/// INFO: Cost tag for unweighted graphs. It is empty, so std::tuple stores
+/// nothing for it and a half edge shrinks to just its target.
+struct Unweighted {
+  auto operator<=>(const Unweighted &) const = default;
+};
+
+// TAG: EdgeCost DECL
+template <class Cost>
+concept EdgeCost =
+    std::is_arithmetic_v<Cost> or std::same_as<Cost, Unweighted>;
+
+// TAG: Distance DECL
+/// INFO: Path length type, unweighted graphs measure it in hops
+template <class Cost, class CounterType>
+using Distance =
+    std::conditional_t<std::same_as<Cost, Unweighted>, CounterType, Cost>;
+template <class CounterType, class Cost>
+using DistanceMap =
+    std::unordered_map<CounterType, Distance<Cost, CounterType>>;
+
 // TAG: DefaultHashMap DECL
 template <class NodeType, class CounterType>
 using DefaultHashMap = std::unordered_map<NodeType, CounterType>;
@@ -38,7 +64,7 @@ template <class Aspect, class CounterType, class H> class Counter;
 template <class NodeType, class Cost = float_t,
           class CounterType = std::uint16_t,
           class H = DefaultHashMap<NodeType, CounterType>>
-  requires Hashable<NodeType> and std::is_arithmetic_v<Cost>
+  requires Hashable<NodeType> and EdgeCost<Cost>
 class DiGraph;
 
 // TAG: DAG DECL
@@ -47,14 +73,14 @@ class DiGraph;
 template <class NodeType, class Cost = float_t,
           class CounterType = std::uint16_t,
           class H = DefaultHashMap<NodeType, CounterType>>
-  requires Hashable<NodeType> and std::is_arithmetic_v<Cost>
+  requires Hashable<NodeType> and EdgeCost<Cost>
 class DAG;
 
 // TAG: UniGraph DECL
 template <class NodeType, class Cost = float_t,
           class CounterType = std::uint16_t,
           class H = DefaultHashMap<NodeType, CounterType>>
-  requires Hashable<NodeType> and std::is_arithmetic_v<Cost>
+  requires Hashable<NodeType> and EdgeCost<Cost>
 class UniGraph;
 
 // TAG: Connectivity DECL
@@ -76,6 +102,25 @@ using CounterHalfEdge = std::tuple<CounterType, Cost>;
 template <class CounterType, class Cost>
 using Edge = std::tuple<CounterType, CounterType, Cost>;
 
+// TAG: Adjacency DECL
+/// INFO: Out edges of one node. Unweighted graphs use a sorted vector, so an
+/// edge costs sizeof(CounterType) instead of a whole tree node.
+template <class T> class FlatSet;
+template <class CounterType, class Cost>
+using Adjacency =
+    std::conditional_t<std::same_as<Cost, Unweighted>,
+                       FlatSet<CounterHalfEdge<CounterType, Cost>>,
+                       std::set<CounterHalfEdge<CounterType, Cost>>>;
+
+// TAG: QueryContext DECL
+template <class CounterType, class Cost> class QueryContext;
+
+// TAG: ExternalDiGraph DECL
+/// INFO: Defined in lean_graph_external.h
+template <class CounterType, class Cost>
+  requires EdgeCost<Cost>
+class ExternalDiGraph;
+
 } // namespace lean_graph
 
 /////////////////////////////////////////////////////////////////
@@ -129,19 +174,154 @@ public:
   CounterType get_counter() const { return count; }
 };
 
+// TAG: FlatSet DEFN
+/// INFO: Sorted vector with the part of std::set's interface DiGraph uses
+template <class T> class FlatSet {
+  std::vector<T> items;
+
+public:
+  auto begin() const { return items.begin(); }
+  auto end() const { return items.end(); }
+  auto size() const -> std::size_t { return items.size(); }
+  bool contains(const T &item) const {
+    return std::ranges::binary_search(items, item);
+  }
+  void insert(const T &item) {
+    auto it = std::ranges::lower_bound(items, item);
+    if (it == items.end() or *it != item)
+      items.insert(it, item);
+  }
+  void erase(const T &item) {
+    auto it = std::ranges::lower_bound(items, item);
+    if (it != items.end() and *it == item)
+      items.erase(it);
+  }
+};
+
+// TAG: QueryContext DEFN
+/// INFO: Per thread scratch space for repeated queries. Every array is indexed
+/// by counter and only ever grows. A slot belongs to the current query only if
+/// its stamp equals the epoch, so starting a new query just bumps the epoch
+/// instead of clearing anything.
+template <class CounterType, class Cost> class QueryContext {
+  using Dist = Distance<Cost, CounterType>;
+
+  std::vector<Dist> dist;
+  std::vector<CounterType> prev;
+  std::vector<std::uint32_t> dist_stamp, visit_stamp;
+  std::uint32_t epoch = 0;
+
+  std::vector<std::tuple<Dist, CounterType>> heap;
+  std::vector<std::tuple<CounterType, VisitOrder>> frontier;
+  std::vector<CounterType> order;
+
+  /// INFO: Start a new query over counters [0, num_node)
+  void begin(std::size_t num_node) {
+    if (dist.size() < num_node) {
+      dist.resize(num_node);
+      prev.resize(num_node);
+      dist_stamp.resize(num_node, 0);
+      visit_stamp.resize(num_node, 0);
+    }
+    // NOTE: on wrap around old stamps could collide with the new epoch
+    if (++epoch == 0) {
+      std::ranges::fill(dist_stamp, 0);
+      std::ranges::fill(visit_stamp, 0);
+      epoch = 1;
+    }
+    heap.clear();
+    frontier.clear();
+    order.clear();
+  }
+
+  void relax(CounterType node, Dist d, CounterType parent_node) {
+    dist[node] = d;
+    prev[node] = parent_node;
+    dist_stamp[node] = epoch;
+  }
+  bool visited(CounterType node) const { return visit_stamp[node] == epoch; }
+  void visit(CounterType node) { visit_stamp[node] = epoch; }
+
+public:
+  /// INFO: Whether the last shortest path query reached the node
+  bool reached(CounterType node) const {
+    return node < dist_stamp.size() and dist_stamp[node] == epoch;
+  }
+  /// INFO: Only meaningful if reached(node)
+  Dist distance(CounterType node) const { return dist[node]; }
+  /// INFO: Only meaningful if reached(node), the source is its own parent
+  CounterType parent(CounterType node) const { return prev[node]; }
+  /// INFO: Nodes of the last explore_dfs() or explore_bfs() in visit order
+  const std::vector<CounterType> &visit_order() const { return order; }
+
+  template <class N, class C, class CT, class HH>
+    requires Hashable<N> and EdgeCost<C>
+  friend class DiGraph;
+  template <class N, class C, class CT, class HH>
+    requires Hashable<N> and EdgeCost<C>
+  friend class DAG;
+  template <class CT, class C>
+    requires EdgeCost<C>
+  friend class ExternalDiGraph;
+};
+
 template <class CounterType, class Cost> class EdgeIte {};
 ///
 // TAG: DiGraph DEFN
 template <class NodeType, class Cost, class CounterType, class H>
-  requires Hashable<NodeType> and std::is_arithmetic_v<Cost>
+  requires Hashable<NodeType> and EdgeCost<Cost>
 class DiGraph {
 public:
 protected:
-  std::unordered_map<CounterType, std::set<CounterHalfEdge<CounterType, Cost>>>
-      graph;
+  std::unordered_map<CounterType, Adjacency<CounterType, Cost>> graph;
 
   Counter<NodeType, CounterType, H> node_counter{0};
   CounterType num_node, num_edge;
+  static constexpr bool unweighted = std::same_as<Cost, Unweighted>;
+  /// NOTE: registerEdge doesn't require registered endpoints, so this tracks
+  /// one past the largest counter any edge mentions
+  std::size_t counter_span = 0;
+
+  auto note_edge(CounterType from, CounterType to) -> void {
+    counter_span = std::max({counter_span, static_cast<std::size_t>(from) + 1,
+                             static_cast<std::size_t>(to) + 1});
+  }
+  /// INFO: How many counters a QueryContext must cover for this graph
+  auto context_size() const -> std::size_t {
+    return std::max<std::size_t>(node_counter.get_counter(), counter_span);
+  }
+
+  /// INFO: Single source hop distances, used in place of dijkstra and bellman
+  /// ford when the graph is unweighted
+  auto bfs_shortest_paths(CounterType start) const
+      -> std::pair<DistanceMap<CounterType, Cost>,
+                   std::unordered_map<CounterType, CounterType>> {
+    if (not existCounterNode(start))
+      return {{}, {}};
+    DistanceMap<CounterType, Cost> dist_from_start;
+    std::unordered_map<CounterType, CounterType> prev;
+    std::queue<CounterType> q;
+
+    dist_from_start[start] = 0;
+    q.push(start);
+    while (not q.empty()) {
+      auto node = q.front();
+      q.pop();
+
+      auto neighbors = graph.find(node);
+      if (neighbors == graph.end())
+        continue;
+      for (auto &[neighbor, cost] : (*neighbors).second) {
+        if (dist_from_start.contains(neighbor))
+          continue;
+        dist_from_start[neighbor] = dist_from_start[node] + 1;
+        prev[neighbor] = node;
+        q.push(neighbor);
+      }
+    }
+
+    return {dist_from_start, prev};
+  }
   template <VisitOrder v>
   auto explore_dfs_protected(
       CounterType from,
@@ -160,9 +340,12 @@ protected:
     while (not stck.empty()) {
       auto [current_node, visit_order] = stck.top();
       stck.pop();
-      visited.insert(current_node);
 
       if (visit_order == VisitOrder::pre) {
+        // NOTE: a node can be pushed once per in edge, only the first counts
+        if (visited.contains(current_node))
+          continue;
+        visited.insert(current_node);
         if constexpr (v == VisitOrder::pre)
           result.push_back(current_node);
 
@@ -200,9 +383,12 @@ protected:
     while (not q.empty()) {
       auto [current_node, visit_order] = q.front();
       q.pop();
-      visited.insert(current_node);
 
       if (visit_order == VisitOrder::pre) {
+        // NOTE: a node can be pushed once per in edge, only the first counts
+        if (visited.contains(current_node))
+          continue;
+        visited.insert(current_node);
         if constexpr (v == VisitOrder::pre)
           result.push_back(current_node);
 
@@ -222,6 +408,96 @@ protected:
     return result;
   }
 
+  /// INFO: Same as bfs_shortest_paths but fills a reusable context, the
+  /// discovered nodes double as the bfs queue
+  auto bfs_shortest_paths(CounterType start,
+                          QueryContext<CounterType, Cost> &ctx) const -> void {
+    ctx.relax(start, 0, start);
+    ctx.order.push_back(start);
+    for (std::size_t head = 0; head < ctx.order.size(); head++) {
+      auto node = ctx.order[head];
+
+      auto neighbors = graph.find(node);
+      if (neighbors == graph.end())
+        continue;
+      for (auto &[neighbor, cost] : (*neighbors).second) {
+        if (ctx.reached(neighbor))
+          continue;
+        ctx.relax(neighbor, ctx.dist[node] + 1, node);
+        ctx.order.push_back(neighbor);
+      }
+    }
+  }
+
+  /// INFO: Context variant of explore_dfs_protected, appends to ctx.order
+  template <VisitOrder v>
+  auto explore_dfs_protected(CounterType from,
+                             QueryContext<CounterType, Cost> &ctx) const
+      -> void {
+    using tup = std::tuple<CounterType, VisitOrder>;
+    auto &stck = ctx.frontier;
+    stck.clear();
+
+    stck.push_back(tup(from, VisitOrder::pre));
+    while (not stck.empty()) {
+      auto [current_node, visit_order] = stck.back();
+      stck.pop_back();
+
+      if (visit_order == VisitOrder::pre) {
+        if (ctx.visited(current_node))
+          continue;
+        ctx.visit(current_node);
+        if constexpr (v == VisitOrder::pre)
+          ctx.order.push_back(current_node);
+
+        stck.push_back(tup(current_node, VisitOrder::post));
+        auto neighbors = graph.find(current_node);
+        if (neighbors == graph.end())
+          continue;
+        for (auto &[neighbor, cost] : (*neighbors).second) {
+          if (ctx.visited(neighbor))
+            continue;
+          stck.push_back(tup(neighbor, VisitOrder::pre));
+        }
+      } else if constexpr (v == VisitOrder::post)
+        ctx.order.push_back(current_node);
+    }
+  }
+
+  /// INFO: Context variant of explore_bfs_protected, appends to ctx.order
+  template <VisitOrder v>
+  auto explore_bfs_protected(CounterType from,
+                             QueryContext<CounterType, Cost> &ctx) const
+      -> void {
+    using tup = std::tuple<CounterType, VisitOrder>;
+    auto &q = ctx.frontier;
+    q.clear();
+
+    q.push_back(tup(from, VisitOrder::pre));
+    for (std::size_t head = 0; head < q.size(); head++) {
+      auto [current_node, visit_order] = q[head];
+
+      if (visit_order == VisitOrder::pre) {
+        if (ctx.visited(current_node))
+          continue;
+        ctx.visit(current_node);
+        if constexpr (v == VisitOrder::pre)
+          ctx.order.push_back(current_node);
+
+        q.push_back(tup(current_node, VisitOrder::post));
+        auto neighbors = graph.find(current_node);
+        if (neighbors == graph.end())
+          continue;
+        for (auto &[neighbor, cost] : (*neighbors).second) {
+          if (ctx.visited(neighbor))
+            continue;
+          q.push_back(tup(neighbor, VisitOrder::pre));
+        }
+      } else if constexpr (v == VisitOrder::post)
+        ctx.order.push_back(current_node);
+    }
+  }
+
 public:
   auto registerNode(const NodeType &node) -> CounterType {
     if (!node_counter.exist(node))
@@ -233,6 +509,7 @@ public:
     const auto [from, to, cost] = edge;
     if (!existEdge(edge))
       num_edge++;
+    note_edge(from, to);
     this->graph[from].insert({to, cost});
     return;
   }
@@ -345,6 +622,28 @@ public:
     return explore_bfs_protected<v>(from, std::nullopt);
   }
 
+  /// INFO: explore_dfs() into a reusable context, no allocation once the
+  /// context has grown to the graph size. Also readable via ctx.visit_order()
+  template <VisitOrder v>
+  auto explore_dfs(CounterType from, QueryContext<CounterType, Cost> &ctx) const
+      -> const std::vector<CounterType> & {
+    ctx.begin(context_size());
+    if (existCounterNode(from))
+      explore_dfs_protected<v>(from, ctx);
+    return ctx.order;
+  }
+
+  /// INFO: explore_bfs() into a reusable context, no allocation once the
+  /// context has grown to the graph size. Also readable via ctx.visit_order()
+  template <VisitOrder v>
+  auto explore_bfs(CounterType from, QueryContext<CounterType, Cost> &ctx) const
+      -> const std::vector<CounterType> & {
+    ctx.begin(context_size());
+    if (existCounterNode(from))
+      explore_bfs_protected<v>(from, ctx);
+    return ctx.order;
+  }
+
   /// INFO: Johnson algorithm
   [[nodiscard("\nDON'T DISCARD THE RESULT OF cycles(), WHICH RETURNS A VECTOR "
               "OF ELEMENTARY CYCLES\n")]]
@@ -361,37 +660,87 @@ public:
       "\nDon't discard the result of djikstra's singular shorest path.\n")]]
   virtual auto /* DiGraph */ singular_shortest_path(CounterType start,
                                                     CounterType end) const
-      -> std::pair<std::unordered_map<CounterType, Cost>,
+      -> std::pair<DistanceMap<CounterType, Cost>,
                    std::unordered_map<CounterType, CounterType>> {
-    if (not existCounterNode(start))
-      return {{}, {}};
-    std::unordered_map<CounterType, Cost> dist_from_start;
-    std::unordered_map<CounterType, CounterType> prev;
-    dist_from_start[start] = 0;
-    std::priority_queue<std::tuple<Cost, CounterType>,
-                        std::vector<std::tuple<Cost, CounterType>>,
-                        decltype(std::greater<>())>
-        pq(std::greater<>{});
-
-    pq.emplace(dist_from_start[start], start);
-    while (not pq.empty()) {
-      auto [dist_node, node] = pq.top();
-      pq.pop();
-
-      for (auto [neighbor, cost] : (*graph.find(node)).second) {
-        if (not dist_from_start.contains(neighbor) or
-            (dist_from_start[neighbor] > dist_from_start[node] + cost)) {
-          dist_from_start[neighbor] = dist_from_start[node] + cost;
-          prev[neighbor] = node;
-          pq.emplace(dist_from_start[neighbor], neighbor);
+    if constexpr (unweighted) {
+      auto result = bfs_shortest_paths(start);
+      if (not result.second.contains(end))
+        return {{}, {}};
+      return result;
+    } else {
+      if (not existCounterNode(start))
+        return {{}, {}};
+      DistanceMap<CounterType, Cost> dist_from_start;
+      std::unordered_map<CounterType, CounterType> prev;
+      dist_from_start[start] = 0;
+      std::priority_queue<std::tuple<Cost, CounterType>,
+                          std::vector<std::tuple<Cost, CounterType>>,
+                          decltype(std::greater<>())>
+          pq(std::greater<>{});
+
+      pq.emplace(dist_from_start[start], start);
+      while (not pq.empty()) {
+        auto [dist_node, node] = pq.top();
+        pq.pop();
+
+        auto neighbors = graph.find(node);
+        if (neighbors == graph.end())
+          continue;
+        for (auto [neighbor, cost] : (*neighbors).second) {
+          if (not dist_from_start.contains(neighbor) or
+              (dist_from_start[neighbor] > dist_from_start[node] + cost)) {
+            dist_from_start[neighbor] = dist_from_start[node] + cost;
+            prev[neighbor] = node;
+            pq.emplace(dist_from_start[neighbor], neighbor);
+          }
         }
       }
+
+      if (not prev.contains(end))
+        return {{}, {}};
+
+      return {dist_from_start, prev};
     }
+  }
 
-    if (not prev.contains(end))
-      return {{}, {}};
+  /// INFO: Dijkstra into a reusable context, read the result back with
+  /// ctx.distance() and ctx.parent(). Returns whether end was reached.
+  virtual auto /* DiGraph */ singular_shortest_path(
+      CounterType start, CounterType end,
+      QueryContext<CounterType, Cost> &ctx) const -> bool {
+    ctx.begin(context_size());
+    if (not existCounterNode(start))
+      return false;
+    if constexpr (unweighted) {
+      bfs_shortest_paths(start, ctx);
+    } else {
+      auto &pq = ctx.heap;
+      const auto cmp = std::greater<>{};
+
+      ctx.relax(start, 0, start);
+      pq.emplace_back(0, start);
+      while (not pq.empty()) {
+        std::ranges::pop_heap(pq, cmp);
+        auto [dist_node, node] = pq.back();
+        pq.pop_back();
+        if (dist_node > ctx.dist[node]) // stale entry
+          continue;
 
-    return {dist_from_start, prev};
+        auto neighbors = graph.find(node);
+        if (neighbors == graph.end())
+          continue;
+        for (auto [neighbor, cost] : (*neighbors).second) {
+          if (not ctx.reached(neighbor) or
+              ctx.dist[neighbor] > dist_node + cost) {
+            ctx.relax(neighbor, dist_node + cost, node);
+            pq.emplace_back(dist_node + cost, neighbor);
+            std::ranges::push_heap(pq, cmp);
+          }
+        }
+      }
+    }
+
+    return existCounterNode(end) and ctx.reached(end);
   }
 
   /// INFO: Single source, multi paths bellman ford algorithm
@@ -401,50 +750,91 @@ public:
   /// If you're not a nerd, please be careful
   [[nodiscard("\nDon't discard the result of bellman_ford\n")]]
   auto bellman_ford(CounterType start) const
-      -> std::pair<std::unordered_map<CounterType, Cost>,
+      -> std::pair<DistanceMap<CounterType, Cost>,
                    std::unordered_map<CounterType, CounterType>> const {
-    std::unordered_map<CounterType, Cost> cost_map;
-    std::unordered_map<CounterType, CounterType> prev;
+    if constexpr (unweighted) {
+      // INFO: hop counts can't form a negative cycle, bfs is enough
+      return bfs_shortest_paths(start);
+    } else {
+      DistanceMap<CounterType, Cost> cost_map;
+      std::unordered_map<CounterType, CounterType> prev;
+
+      auto edges = this->edges();
+
+      auto num_vertex_minus_1 = this->num_node - 1;
+      cost_map[start] = 0;
+      while (num_vertex_minus_1) {
+        for (auto &[from, to, cost] : edges) {
+          if (not cost_map.contains(from) && not cost_map.contains(to))
+            continue;
+          if (not cost_map.contains(from)) // if we don't do this, big fat ass
+            continue;                      // trouble of over-flowing
 
-    auto edges = this->edges();
+          auto &a = cost_map[from];
+          auto b = cost_map.contains(to) ? cost_map[to]
+                                         : std::numeric_limits<Cost>::max();
+
+          if (a + cost < b) {
+            a = a + cost;
+            prev[to] = from;
+          }
+        }
 
-    auto num_vertex_minus_1 = this->num_node - 1;
-    cost_map[start] = 0;
-    while (num_vertex_minus_1) {
+        num_vertex_minus_1--;
+      }
       for (auto &[from, to, cost] : edges) {
         if (not cost_map.contains(from) && not cost_map.contains(to))
           continue;
-        if (not cost_map.contains(from)) // if we don't do this, big fat ass
-          continue;                      // trouble of over-flowing
+        if (not cost_map.contains(from))
+          continue;
 
         auto &a = cost_map[from];
         auto b = cost_map.contains(to) ? cost_map[to]
                                        : std::numeric_limits<Cost>::max();
 
-        if (a + cost < b) {
-          a = a + cost;
-          prev[to] = from;
-        }
+        // INFO: negative cycle detected
+        if (a + cost < b)
+          return {};
       }
 
-      num_vertex_minus_1--;
+      return {cost_map, prev};
     }
-    for (auto &[from, to, cost] : edges) {
-      if (not cost_map.contains(from) && not cost_map.contains(to))
-        continue;
-      if (not cost_map.contains(from))
-        continue;
+  }
 
-      auto &a = cost_map[from];
-      auto b = cost_map.contains(to) ? cost_map[to]
-                                     : std::numeric_limits<Cost>::max();
+  /// INFO: Bellman ford into a reusable context, relaxing straight off the
+  /// adjacency instead of copying edges(). Returns false on a negative cycle.
+  auto bellman_ford(CounterType start,
+                    QueryContext<CounterType, Cost> &ctx) const -> bool {
+    ctx.begin(context_size());
+    if (not existCounterNode(start))
+      return false;
+    if constexpr (unweighted) {
+      bfs_shortest_paths(start, ctx);
+      return true;
+    } else {
+      auto relax_all = [&]() {
+        bool changed = false;
+        for (auto &[from, neighbors_info] : graph) {
+          if (not ctx.reached(from))
+            continue;
+          for (auto &[to, cost] : neighbors_info) {
+            if (ctx.reached(to) and not(ctx.dist[from] + cost < ctx.dist[to]))
+              continue;
+            ctx.relax(to, ctx.dist[from] + cost, from);
+            changed = true;
+          }
+        }
+        return changed;
+      };
+
+      ctx.relax(start, 0, start);
+      for (std::size_t i = 1; i < context_size(); i++)
+        if (not relax_all())
+          return true;
 
       // INFO: negative cycle detected
-      if (a + cost < b)
-        return {};
+      return not relax_all();
     }
-
-    return {cost_map, prev};
   }
 
   /// INFO: Strongly connected components (SCC)
@@ -457,7 +847,7 @@ public:
 
 // TAG: DAG DEFN
 template <class NodeType, class Cost, class CounterType, class H>
-  requires Hashable<NodeType> and std::is_arithmetic_v<Cost>
+  requires Hashable<NodeType> and EdgeCost<Cost>
 class DAG : public DiGraph<NodeType, Cost, CounterType, H> {
 public:
   // A topological sort is a reversed post order
@@ -469,39 +859,76 @@ public:
 
   virtual auto /* DAG */ singular_shortest_path(CounterType start,
                                                 CounterType end) const
-      -> std::pair<std::unordered_map<CounterType, Cost>,
+      -> std::pair<DistanceMap<CounterType, Cost>,
                    std::unordered_map<CounterType, CounterType>> override {
+    using dg = DiGraph<NodeType, Cost, CounterType, H>;
+    if constexpr (dg::unweighted) {
+      return dg::singular_shortest_path(start, end);
+    } else {
+      if (not this->existCounterNode(start))
+        return {{}, {}};
+      DistanceMap<CounterType, Cost> dist_from_start;
+      std::unordered_map<CounterType, CounterType> prev;
+      dist_from_start[start] = 0;
+
+      auto linearized_graph_nodes = this->topo_sort();
+
+      for (auto node : linearized_graph_nodes) {
+        auto neighbors = this->graph.find(node);
+        if (neighbors == this->graph.end())
+          continue;
+        for (auto [neighbor, cost] : (*neighbors).second) {
 
-    if (not this->existCounterNode(start))
-      return {{}, {}};
-    std::unordered_map<CounterType, Cost> dist_from_start;
-    std::unordered_map<CounterType, CounterType> prev;
-    dist_from_start[start] = 0;
+          if (not dist_from_start.contains(neighbor) or
+              (dist_from_start[neighbor] > dist_from_start[node] + cost)) {
+            dist_from_start[neighbor] = dist_from_start[node] + cost;
+            prev[neighbor] = node;
+          }
+        }
+      }
 
-    auto linearized_graph_nodes = this->topo_sort();
+      // if in the end we don't have the end node, sth seriously wrong with you
+      // or me hahahah
+      if (not prev.contains(end))
+        return {{}, {}};
 
-    for (auto node : linearized_graph_nodes) {
-      for (auto [neighbor, cost] : (*this->graph.find(node)).second) {
+      return {dist_from_start, prev};
+    }
+  }
 
-        if (not dist_from_start.contains(neighbor) or
-            (dist_from_start[neighbor] > dist_from_start[node] + cost)) {
-          dist_from_start[neighbor] = dist_from_start[node] + cost;
-          prev[neighbor] = node;
+  virtual auto /* DAG */ singular_shortest_path(
+      CounterType start, CounterType end,
+      QueryContext<CounterType, Cost> &ctx) const -> bool override {
+    using dg = DiGraph<NodeType, Cost, CounterType, H>;
+    if constexpr (dg::unweighted) {
+      return dg::singular_shortest_path(start, end, ctx);
+    } else {
+      ctx.begin(this->context_size());
+      if (not this->existCounterNode(start))
+        return false;
+
+      // INFO: The reversed post order from start is a topological order of
+      // every node start can reach, which is all we need to relax
+      this->template explore_dfs_protected<VisitOrder::post>(start, ctx);
+      ctx.relax(start, 0, start);
+      for (auto node : ctx.order | std::views::reverse) {
+        auto neighbors = this->graph.find(node);
+        if (neighbors == this->graph.end())
+          continue;
+        for (auto [neighbor, cost] : (*neighbors).second) {
+          if (not ctx.reached(neighbor) or
+              ctx.dist[neighbor] > ctx.dist[node] + cost)
+            ctx.relax(neighbor, ctx.dist[node] + cost, node);
         }
       }
-    }
-
-    // if in the end we don't have the end node, sth seriously wrong with you or
-    // me hahahah
-    if (not prev.contains(end))
-      return {{}, {}};
 
-    return {dist_from_start, prev};
+      return this->existCounterNode(end) and ctx.reached(end);
+    }
   }
 };
 // TAG: UniGraph DEFN
 template <class NodeType, class Cost, class CounterType, class H>
-  requires Hashable<NodeType> and std::is_arithmetic_v<Cost>
+  requires Hashable<NodeType> and EdgeCost<Cost>
 class UniGraph : DiGraph<NodeType, Cost, CounterType, H> {
 
 public:
@@ -510,6 +937,7 @@ public:
     if (!this->existEdge(edge))
       this->num_edge++;
     const auto [from, to, cost] = edge;
+    this->note_edge(from, to);
     this->graph[from].insert({to, cost});
     this->graph[to].insert({from, cost});
     return;
@@ -549,51 +977,88 @@ public:
       -> std::vector<std::vector<CounterType>> override {
     return {};
   }
+  /// INFO: On an unweighted graph every spanning forest is minimal, so edges
+  /// are taken in storage order without sorting
   auto /* UniGraph */ mst_kruskal()
       -> std::vector<CounterEdge<CounterType, Cost>> {
     Connectivity<CounterType, H> conn;
 
     auto edges = this->edges();
-    std::priority_queue<CounterEdge<CounterType, Cost>,
-                        std::vector<CounterEdge<CounterType, Cost>>,
-                        decltype([](auto a, auto b) {
-                          return std::get<2>(a) > std::get<2>(b);
-                        })>
-        pq{};
-    pq.push_range(edges);
-
-    decltype(mst_kruskal()) mst;
-    while (!pq.empty()) {
-      auto [from, to, cost] = pq.top();
-      pq.pop();
-      if (not conn.is_connected(from, to)) {
-        conn.unite(from, to);
-        mst.push_back({from, to, cost});
+    if constexpr (DiGraph<NodeType, Cost, CounterType, H>::unweighted) {
+      decltype(mst_kruskal()) forest;
+      for (auto &[from, to, cost] : edges) {
+        if (not conn.is_connected(from, to)) {
+          conn.unite(from, to);
+          forest.push_back({from, to, cost});
+        }
+      }
+      return forest;
+    } else {
+      std::priority_queue<CounterEdge<CounterType, Cost>,
+                          std::vector<CounterEdge<CounterType, Cost>>,
+                          decltype([](auto a, auto b) {
+                            return std::get<2>(a) > std::get<2>(b);
+                          })>
+          pq{};
+      pq.push_range(edges);
+
+      decltype(mst_kruskal()) mst;
+      while (!pq.empty()) {
+        auto [from, to, cost] = pq.top();
+        pq.pop();
+        if (not conn.is_connected(from, to)) {
+          conn.unite(from, to);
+          mst.push_back({from, to, cost});
+        }
       }
-    }
 
-    return mst;
+      return mst;
+    }
   }
 };
 // A topological sort is a reversed post order
 
 // TAG: CONNECTIVITY DEFN
-/// INFO: Connectivity is just glorified union find, this is from DPV book
+/// INFO: Connectivity is just glorified union find, this is from DPV book.
+/// With H = std::vector<CounterType> parents and ranks are dense arrays sized
+/// up front, otherwise both are hash maps filled lazily.
 template <class CounterType, class H> class Connectivity {
+  static constexpr bool dense = std::same_as<H, std::vector<CounterType>>;
+
   H uf;
-  std::unordered_map<CounterType, uint32_t> rank;
+  std::conditional_t<dense, std::vector<std::uint8_t>,
+                     std::unordered_map<CounterType, uint32_t>>
+      rank;
 
-  /// INFO: find with path compression
-  CounterType /* Connectivity */ find(CounterType a) {
-    if (uf.find(a) == uf.end()) // lazy rank computation
-      return a;
+  CounterType /* Connectivity */ parent(CounterType a) const {
+    if constexpr (dense)
+      return uf[a];
+    else {
+      auto it = uf.find(a);
+      return it == uf.end() ? a : (*it).second; // lazy rank computation
+    }
+  }
 
-    if (a != uf[a])
-      uf[a] = find(uf[a]);
-    return uf[a];
+  /// INFO: find with path halving, iterative so deep trees can't overflow
+  /// the stack
+  CounterType /* Connectivity */ find(CounterType a) {
+    while (parent(a) != a) {
+      auto grand_parent = parent(parent(a));
+      uf[a] = grand_parent;
+      a = grand_parent;
+    }
+    return a;
   }
 
 public:
+  Connectivity() = default;
+  /// INFO: Dense union find over counters [0, num_node)
+  explicit Connectivity(std::size_t num_node)
+    requires dense
+      : uf(num_node), rank(num_node, 0) {
+    std::iota(uf.begin(), uf.end(), CounterType{0});
+  }
+
   bool /* Connectivity */ is_connected(CounterType a, CounterType b) {
     return this->find(a) == this->find(b);
   }
@@ -609,7 +1074,7 @@ public:
     if (rank[ra] > rank[rb])
       uf[rb] = ra;
     else {
-      uf[ra] = uf[rb];
+      uf[ra] = rb;
       if (rank[ra] == rank[rb])
         rank[rb] = rank[rb] + 1;
     }
@@ -0,0 +1,651 @@
+#pragma once
+#include "lean_graph.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <expected>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+#include <string>
+#include <thread>
+#include <vector>
+
+/////////////////////////////////////////////////////////////////
+/////////////////////////// START DECL SPACE
+/////////////////////////////////////////////////////////////////
+namespace lean_graph {
+enum class io_error {
+  open_failed,
+  read_failed,
+  write_failed,
+  bad_format,
+  unsorted
+};
+
+// TAG: ExternalBlock DECL
+/// INFO: Index entry of one compressed block in an edge file
+struct ExternalBlock;
+
+// TAG: IOStats DECL
+struct IOStats;
+
+// TAG: ExternalEdgeWriter DECL
+template <class CounterType = std::uint64_t, class Cost = float_t>
+  requires EdgeCost<Cost>
+class ExternalEdgeWriter;
+
+// TAG: BlockPrefetcher DECL
+template <class CounterType, class Cost>
+  requires EdgeCost<Cost>
+class BlockPrefetcher;
+
+// TAG: ExternalDiGraph DECL
+/// INFO: A DiGraph whose adjacency stays on disk, only per-node state is kept
+/// in memory.
+template <class CounterType = std::uint64_t, class Cost = float_t>
+  requires EdgeCost<Cost>
+class ExternalDiGraph;
+} // namespace lean_graph
+
+/////////////////////////////////////////////////////////////////
+/////////////////////////// END DECL SPACE
+/////////////////////////////////////////////////////////////////
+//
+//
+//
+/////////////////////////////////////////////////////////////////
+/////////////////////////// START DEFN SPACE
+/////////////////////////////////////////////////////////////////
+namespace lean_graph {
+
+// TAG: ExternalBlock DEFN
+/// INFO: Edge file layout, all integers in host byte order:
+///
+///   ExternalHeader | block 0 | block 1 | ... | ExternalBlock[num_blocks]
+///
+/// Edges are sorted by source. Inside a block they are grouped in runs of one
+/// source: varint source delta, varint run length, then per edge a zigzag
+/// varint target delta followed by the raw cost (nothing if Unweighted).
+struct ExternalBlock {
+  std::uint64_t offset, first_source, last_source;
+  std::uint32_t bytes, edges;
+};
+
+struct ExternalHeader {
+  char magic[4];
+  std::uint32_t cost_type;
+  std::uint64_t num_node, num_edge, num_blocks, index_offset;
+};
+
+inline constexpr char external_magic[4] = {'L', 'G', 'E', 'X'};
+
+/// INFO: Cost size plus float and sign bits, so a file can't be opened with a
+/// Cost it wasn't written with. Unweighted is 0.
+template <class Cost> constexpr auto external_cost_type() -> std::uint32_t {
+  if constexpr (std::same_as<Cost, Unweighted>)
+    return 0;
+  else
+    return sizeof(Cost) | std::is_floating_point_v<Cost> << 8 |
+           std::is_signed_v<Cost> << 9;
+}
+
+// TAG: IOStats DEFN
+/// INFO: Accumulated over every pass an ExternalDiGraph streams
+struct IOStats {
+  std::uint64_t passes = 0, blocks_read = 0, bytes_read = 0,
+                edges_streamed = 0;
+  std::chrono::nanoseconds elapsed{0};
+
+  double seconds() const {
+    return std::chrono::duration<double>(elapsed).count();
+  }
+  double bytes_per_second() const {
+    return seconds() > 0 ? bytes_read / seconds() : 0;
+  }
+  double edges_per_second() const {
+    return seconds() > 0 ? edges_streamed / seconds() : 0;
+  }
+};
+
+// TAG: ExternalEdgeWriter DEFN
+/// INFO: Builds an edge file from edges appended in source order
+template <class CounterType, class Cost>
+  requires EdgeCost<Cost>
+class ExternalEdgeWriter {
+  static constexpr bool unweighted = std::same_as<Cost, Unweighted>;
+
+  std::ofstream out;
+  std::vector<ExternalBlock> index;
+  std::vector<char> block, run;
+  std::uint32_t edges_per_block;
+  std::uint64_t num_node = 0, num_edge = 0;
+
+  // current run, only valid while run_length > 0
+  CounterType run_source = 0, prev_target = 0;
+  std::uint64_t run_length = 0, prev_source = 0;
+
+  explicit ExternalEdgeWriter(std::uint32_t edges_per_block)
+      : edges_per_block(edges_per_block) {}
+
+  static void put_varint(std::vector<char> &buf, std::uint64_t x) {
+    while (x >= 0x80) {
+      buf.push_back(static_cast<char>(x | 0x80));
+      x >>= 7;
+    }
+    buf.push_back(static_cast<char>(x));
+  }
+
+  void flush_run() {
+    if (run_length == 0)
+      return;
+    put_varint(block, run_source - prev_source);
+    put_varint(block, run_length);
+    block.insert(block.end(), run.begin(), run.end());
+    prev_source = run_source;
+    run.clear();
+    run_length = 0;
+  }
+
+  auto flush_block() -> std::optional<io_error> {
+    flush_run();
+    if (index.empty() or index.back().edges == 0)
+      return std::nullopt;
+    auto &b = index.back();
+    b.offset = static_cast<std::uint64_t>(out.tellp());
+    b.bytes = static_cast<std::uint32_t>(block.size());
+    if (not out.write(block.data(), block.size()))
+      return io_error::write_failed;
+    block.clear();
+    return std::nullopt;
+  }
+
+public:
+  static auto create(const std::string &path,
+                     std::uint32_t edges_per_block = 1 << 16)
+      -> std::expected<ExternalEdgeWriter, io_error> {
+    ExternalEdgeWriter writer(std::max<std::uint32_t>(edges_per_block, 1));
+    writer.out.open(path, std::ios::binary | std::ios::trunc);
+    if (not writer.out)
+      return std::unexpected(io_error::open_failed);
+
+    // NOTE: placeholder, the real header is written by finish()
+    ExternalHeader header{};
+    if (not writer.out.write(reinterpret_cast<const char *>(&header),
+                             sizeof(header)))
+      return std::unexpected(io_error::write_failed);
+    return writer;
+  }
+
+  /// INFO: Edges must come in non decreasing source order
+  auto append(CounterEdge<CounterType, Cost> edge) -> std::optional<io_error> {
+    const auto &[from, to, cost] = edge;
+    if (not index.empty() and index.back().edges > 0 and
+        from < index.back().last_source)
+      return io_error::unsorted;
+
+    if (index.empty() or index.back().edges == edges_per_block) {
+      if (auto err = flush_block())
+        return err;
+      index.push_back({0, from, from, 0, 0});
+      prev_source = from;
+    }
+    if (run_length == 0 or from != run_source) {
+      flush_run();
+      run_source = prev_target = from;
+    }
+
+    auto delta = static_cast<std::int64_t>(to) -
+                 static_cast<std::int64_t>(prev_target);
+    put_varint(run, (static_cast<std::uint64_t>(delta) << 1) ^
+                        static_cast<std::uint64_t>(delta >> 63));
+    if constexpr (not unweighted) {
+      const char *raw = reinterpret_cast<const char *>(&cost);
+      run.insert(run.end(), raw, raw + sizeof(Cost));
+    }
+    prev_target = to;
+    run_length++;
+
+    index.back().last_source = from;
+    index.back().edges++;
+    num_node = std::max<std::uint64_t>({num_node, from + 1ull, to + 1ull});
+    num_edge++;
+    return std::nullopt;
+  }
+
+  /// INFO: Writes the index and header. Node counters below num_node_hint
+  /// exist even if no edge touches them.
+  auto finish(std::uint64_t num_node_hint = 0) -> std::optional<io_error> {
+    if (auto err = flush_block())
+      return err;
+
+    ExternalHeader header{};
+    std::memcpy(header.magic, external_magic, sizeof(header.magic));
+    header.cost_type = external_cost_type<Cost>();
+    header.num_node = std::max(num_node, num_node_hint);
+    header.num_edge = num_edge;
+    header.num_blocks = index.size();
+    header.index_offset = static_cast<std::uint64_t>(out.tellp());
+
+    if (not out.write(reinterpret_cast<const char *>(index.data()),
+                      index.size() * sizeof(ExternalBlock)))
+      return io_error::write_failed;
+    out.seekp(0);
+    if (not out.write(reinterpret_cast<const char *>(&header),
+                      sizeof(header)))
+      return io_error::write_failed;
+    out.close();
+    return out ? std::nullopt : std::optional(io_error::write_failed);
+  }
+};
+
+// TAG: BlockPrefetcher DEFN
+/// INFO: Owns the edge file and one background thread for the lifetime of an
+/// ExternalDiGraph. Each pass hands it a list of blocks, which it reads and
+/// decodes keeping at most `depth` decoded blocks ahead of the consumer.
+template <class CounterType, class Cost>
+  requires EdgeCost<Cost>
+class BlockPrefetcher {
+public:
+  struct Slot {
+    std::vector<CounterEdge<CounterType, Cost>> edges;
+    std::uint32_t bytes = 0;
+  };
+
+private:
+  static constexpr bool unweighted = std::same_as<Cost, Unweighted>;
+
+  std::ifstream in;
+  const std::vector<ExternalBlock> blocks_index;
+  const std::uint64_t num_node;
+
+  // state of the current pass, guarded by m
+  const std::vector<std::size_t> *blocks = nullptr;
+  std::vector<Slot> ring;
+  std::size_t produced = 0, consumed = 0;
+  std::uint64_t requested_pass = 0;
+  bool finished = true;
+  std::optional<io_error> error;
+  std::mutex m;
+  std::condition_variable_any cv;
+  // NOTE: declared last so it is joined before anything above is destroyed
+  std::jthread worker;
+
+  static bool get_varint(const char *&p, const char *end, std::uint64_t &x) {
+    x = 0;
+    for (int shift = 0; p != end and shift < 64; shift += 7) {
+      auto byte = static_cast<unsigned char>(*p++);
+      x |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+      if (not(byte & 0x80))
+        return true;
+    }
+    return false;
+  }
+
+  /// INFO: Rejects any source outside the block's range and any target
+  /// outside [0, num_node), the algorithms index per-node arrays with both
+  static bool decode(const std::vector<char> &raw, const ExternalBlock &b,
+                     std::uint64_t num_node,
+                     std::vector<CounterEdge<CounterType, Cost>> &edges) {
+    edges.clear();
+    const char *p = raw.data(), *end = raw.data() + raw.size();
+    std::uint64_t source = b.first_source;
+    while (p != end) {
+      std::uint64_t delta, length;
+      if (not get_varint(p, end, delta) or not get_varint(p, end, length))
+        return false;
+      source += delta;
+      if (source < delta or source > b.last_source or length > b.edges)
+        return false;
+      auto target = static_cast<std::int64_t>(source);
+      for (std::uint64_t i = 0; i < length; i++) {
+        std::uint64_t zz;
+        if (not get_varint(p, end, zz))
+          return false;
+        target += static_cast<std::int64_t>(zz >> 1) ^
+                  -static_cast<std::int64_t>(zz & 1);
+        if (target < 0 or static_cast<std::uint64_t>(target) >= num_node)
+          return false;
+        Cost cost{};
+        if constexpr (not unweighted) {
+          if (end - p < static_cast<std::ptrdiff_t>(sizeof(Cost)))
+            return false;
+          std::memcpy(&cost, p, sizeof(Cost));
+          p += sizeof(Cost);
+        }
+        edges.push_back({static_cast<CounterType>(source),
+                         static_cast<CounterType>(target), cost});
+      }
+    }
+    return edges.size() == b.edges;
+  }
+
+  void run(std::stop_token st) {
+    std::vector<char> raw;
+    for (std::uint64_t pass = 1;; pass++) {
+      {
+        std::unique_lock lock(m);
+        if (not cv.wait(lock, st, [&] { return requested_pass == pass; }))
+          return;
+      }
+
+      std::optional<io_error> err;
+      in.clear();
+      for (std::size_t i = 0; not err and i < blocks->size(); i++) {
+        {
+          std::unique_lock lock(m);
+          if (not cv.wait(lock, st,
+                          [&] { return produced - consumed < ring.size(); }))
+            return;
+        }
+        // NOTE: the slot is free, the consumer won't touch it until produced++
+        auto &slot = ring[produced % ring.size()];
+        const auto &b = blocks_index[(*blocks)[i]];
+        raw.resize(b.bytes);
+        in.seekg(static_cast<std::streamoff>(b.offset));
+        if (not in.read(raw.data(), b.bytes))
+          err = io_error::read_failed;
+        else if (not decode(raw, b, num_node, slot.edges))
+          err = io_error::bad_format;
+        else {
+          slot.bytes = b.bytes;
+          std::lock_guard lock(m);
+          produced++;
+        }
+        cv.notify_all();
+      }
+
+      std::lock_guard lock(m);
+      error = err;
+      finished = true;
+      cv.notify_all();
+    }
+  }
+
+public:
+  BlockPrefetcher(std::ifstream in, std::vector<ExternalBlock> index,
+                  std::uint64_t num_node, std::size_t depth)
+      : in(std::move(in)), blocks_index(std::move(index)), num_node(num_node),
+        ring(std::max<std::size_t>(depth, 1)),
+        worker([this](std::stop_token st) { run(st); }) {}
+
+  auto index() const -> const std::vector<ExternalBlock> & {
+    return blocks_index;
+  }
+
+  /// INFO: Only between passes
+  void set_depth(std::size_t depth) {
+    std::lock_guard lock(m);
+    ring.resize(std::max<std::size_t>(depth, 1));
+  }
+
+  /// INFO: Starts reading a pass, the previous one must be fully consumed.
+  /// pass_blocks must outlive the pass.
+  void start(const std::vector<std::size_t> &pass_blocks) {
+    {
+      std::lock_guard lock(m);
+      blocks = &pass_blocks;
+      produced = consumed = 0;
+      finished = false;
+      error.reset();
+      requested_pass++;
+    }
+    cv.notify_all();
+  }
+
+  /// INFO: Blocks until the next block is decoded, nullptr once all blocks
+  /// are consumed or reading failed
+  auto next() -> const Slot * {
+    std::unique_lock lock(m);
+    cv.wait(lock, [&] { return consumed < produced or finished; });
+    return consumed < produced ? &ring[consumed % ring.size()] : nullptr;
+  }
+
+  /// INFO: Hands the slot returned by next() back to the reader
+  void release() {
+    {
+      std::lock_guard lock(m);
+      consumed++;
+    }
+    cv.notify_all();
+  }
+
+  auto status() -> std::optional<io_error> {
+    std::lock_guard lock(m);
+    return error;
+  }
+};
+
+// TAG: ExternalDiGraph DEFN
+/// INFO: Semi-external DiGraph. Per-node state (visited bits, distances,
+/// union find) lives in memory, adjacency is streamed from an edge file
+/// written by ExternalEdgeWriter. Every algorithm is a series of sequential
+/// passes that only read the blocks holding currently active sources.
+template <class CounterType, class Cost>
+  requires EdgeCost<Cost>
+class ExternalDiGraph {
+  static constexpr bool unweighted = std::same_as<Cost, Unweighted>;
+
+  ExternalHeader header{};
+  // NOTE: heap allocated so the reader thread's this survives moves
+  std::unique_ptr<BlockPrefetcher<CounterType, Cost>> reader;
+  IOStats io_stats;
+
+  ExternalDiGraph() = default;
+
+  /// INFO: Streams the listed blocks in order, visit sees one decoded block
+  /// at a time
+  template <class F>
+  auto stream(const std::vector<std::size_t> &blocks, F &&visit)
+      -> std::optional<io_error> {
+    auto start = std::chrono::steady_clock::now();
+    reader->start(blocks);
+    while (auto slot = reader->next()) {
+      visit(slot->edges);
+      io_stats.blocks_read++;
+      io_stats.bytes_read += slot->bytes;
+      io_stats.edges_streamed += slot->edges.size();
+      reader->release();
+    }
+    auto err = reader->status();
+    io_stats.passes++;
+    io_stats.elapsed += std::chrono::steady_clock::now() - start;
+    return err;
+  }
+
+  /// INFO: Blocks holding out edges of the given sources, in file order
+  auto blocks_of(const std::vector<CounterType> &sources) const
+      -> std::vector<std::size_t> {
+    const auto &index = reader->index();
+    std::vector<bool> wanted(index.size());
+    for (auto source : sources) {
+      auto i = std::ranges::partition_point(index, [=](const auto &b) {
+                 return b.last_source < source;
+               }) -
+               index.begin();
+      for (; i < static_cast<std::ptrdiff_t>(index.size()) and
+             index[i].first_source <= source;
+           i++)
+        wanted[i] = true;
+    }
+
+    std::vector<std::size_t> result;
+    for (std::size_t i = 0; i < index.size(); i++)
+      if (wanted[i])
+        result.push_back(i);
+    return result;
+  }
+
+public:
+  static auto open(const std::string &path)
+      -> std::expected<ExternalDiGraph, io_error> {
+    ExternalDiGraph graph;
+    std::ifstream in(path, std::ios::binary);
+    if (not in)
+      return std::unexpected(io_error::open_failed);
+    if (not in.read(reinterpret_cast<char *>(&graph.header),
+                    sizeof(graph.header)))
+      return std::unexpected(io_error::read_failed);
+    if (std::memcmp(graph.header.magic, external_magic,
+                    sizeof(external_magic)) != 0 or
+        graph.header.cost_type != external_cost_type<Cost>())
+      return std::unexpected(io_error::bad_format);
+
+    // NOTE: every counter must fit in CounterType, or per-node arrays would be
+    // indexed with wrapped values
+    const auto &h = graph.header;
+    if (h.num_node > 0 and
+        h.num_node - 1 > std::numeric_limits<CounterType>::max())
+      return std::unexpected(io_error::bad_format);
+
+    in.seekg(0, std::ios::end);
+    const auto file_size = static_cast<std::uint64_t>(in.tellg());
+    if (h.index_offset < sizeof(ExternalHeader) or
+        h.index_offset > file_size or
+        h.num_blocks > (file_size - h.index_offset) / sizeof(ExternalBlock))
+      return std::unexpected(io_error::bad_format);
+
+    std::vector<ExternalBlock> index(h.num_blocks);
+    in.seekg(static_cast<std::streamoff>(h.index_offset));
+    if (not in.read(reinterpret_cast<char *>(index.data()),
+                    index.size() * sizeof(ExternalBlock)))
+      return std::unexpected(io_error::read_failed);
+
+    // INFO: blocks must lie between header and index, in source order
+    std::uint64_t previous_source = 0;
+    for (const auto &b : index) {
+      if (b.offset < sizeof(ExternalHeader) or b.offset > h.index_offset or
+          b.bytes > h.index_offset - b.offset or
+          b.first_source > b.last_source or b.last_source >= h.num_node or
+          b.first_source < previous_source)
+        return std::unexpected(io_error::bad_format);
+      previous_source = b.last_source;
+    }
+
+    graph.reader = std::make_unique<BlockPrefetcher<CounterType, Cost>>(
+        std::move(in), std::move(index), h.num_node, 4);
+    return graph;
+  }
+
+  auto num_nodes() const -> std::uint64_t { return header.num_node; }
+  auto num_edges() const -> std::uint64_t { return header.num_edge; }
+  auto existCounterNode(CounterType node) const -> bool {
+    return node < header.num_node;
+  }
+
+  /// INFO: Number of decoded blocks the reader may run ahead of the algorithm
+  void set_read_ahead(std::size_t depth) { reader->set_depth(depth); }
+  auto stats() const -> const IOStats & { return io_stats; }
+  void reset_stats() { io_stats = {}; }
+
+  /// INFO: Level synchronous bfs, one pass over the frontier's blocks per
+  /// level. Returns nodes in bfs (pre) order.
+  [[nodiscard("\nDON'T DISCARD THE RESULT OF explore_bfs() - BREADTH FIRST "
+              "SEARCH OF A SINGULAR NODE.\n")]]
+  auto explore_bfs(CounterType from)
+      -> std::expected<std::vector<CounterType>, io_error> {
+    if (not existCounterNode(from))
+      return std::vector<CounterType>{};
+    std::vector<bool> visited(header.num_node), in_frontier(header.num_node);
+    std::vector<CounterType> result{from}, frontier;
+    visited[from] = true;
+
+    for (std::size_t level_begin = 0; level_begin < result.size();) {
+      frontier.assign(result.begin() + level_begin, result.end());
+      level_begin = result.size();
+      for (auto node : frontier)
+        in_frontier[node] = true;
+
+      auto err = stream(blocks_of(frontier), [&](const auto &edges) {
+        for (auto &[from_node, to, cost] : edges) {
+          if (not in_frontier[from_node] or visited[to])
+            continue;
+          visited[to] = true;
+          result.push_back(to);
+        }
+      });
+      if (err)
+        return std::unexpected(*err);
+
+      for (auto node : frontier)
+        in_frontier[node] = false;
+    }
+    return result;
+  }
+
+  /// INFO: Single pass over every edge into a dense union find
+  auto connectivity()
+      -> std::expected<Connectivity<CounterType, std::vector<CounterType>>,
+                       io_error> {
+    Connectivity<CounterType, std::vector<CounterType>> conn(header.num_node);
+    std::vector<std::size_t> all(reader->index().size());
+    for (std::size_t i = 0; i < all.size(); i++)
+      all[i] = i;
+
+    auto err = stream(all, [&](const auto &edges) {
+      for (auto &[from, to, cost] : edges)
+        conn.unite(from, to);
+    });
+    if (err)
+      return std::unexpected(*err);
+    return conn;
+  }
+
+  /// INFO: Bellman ford relaxation sweeps into a QueryContext. A sweep only
+  /// reads blocks of sources improved by the previous sweep. Returns false on
+  /// a negative cycle, unweighted graphs relax with cost 1.
+  auto bellman_ford(CounterType start, QueryContext<CounterType, Cost> &ctx)
+      -> std::expected<bool, io_error> {
+    ctx.begin(header.num_node);
+    if (not existCounterNode(start))
+      return false;
+
+    std::vector<bool> changed(header.num_node), next_changed(header.num_node);
+    std::vector<CounterType> active{start}, next_active;
+    ctx.relax(start, 0, start);
+    changed[start] = true;
+
+    for (std::uint64_t sweep = 0; not active.empty(); sweep++) {
+      // INFO: negative cycle detected
+      if (sweep == header.num_node)
+        return false;
+
+      auto err = stream(blocks_of(active), [&](const auto &edges) {
+        for (auto &[from, to, cost] : edges) {
+          if (not changed[from])
+            continue;
+          Distance<Cost, CounterType> weight;
+          if constexpr (unweighted)
+            weight = 1;
+          else
+            weight = cost;
+          if (ctx.reached(to) and not(ctx.dist[from] + weight < ctx.dist[to]))
+            continue;
+          ctx.relax(to, ctx.dist[from] + weight, from);
+          if (not next_changed[to]) {
+            next_changed[to] = true;
+            next_active.push_back(to);
+          }
+        }
+      });
+      if (err)
+        return std::unexpected(*err);
+
+      for (auto node : active)
+        changed[node] = false;
+      std::swap(changed, next_changed);
+      std::swap(active, next_active);
+      next_active.clear();
+    }
+    return true;
+  }
+};
+/////////////////////////////////////////////////////////////////
+/////////////////////////// END DEFN SPACE
+/////////////////////////////////////////////////////////////////
+} // namespace lean_graph
@@ -1,5 +1,7 @@
 #include "lean_graph.h"
+#include "lean_graph_external.h"
 #include <cstdint>
+#include <filesystem>
 #include <iostream>
 #include <unordered_map>
 
@@ -10,6 +12,9 @@ template class DAG<std::string, float_t, uint16_t>;
 template class DiGraph<uint32_t, uint32_t, uint16_t>;
 template class DAG<uint32_t, uint32_t, uint16_t>;
 template class UniGraph<uint32_t, uint32_t, uint16_t>;
+template class DiGraph<uint32_t, Unweighted, uint16_t>;
+template class DAG<uint32_t, Unweighted, uint16_t>;
+template class UniGraph<uint32_t, Unweighted, uint16_t>;
 
 } // namespace lean_graph
 template <class N, class C, class T> void make_graph() {
@@ -44,6 +49,35 @@ template <class N, class C, class T> void make_graph() {
 
   graph.singular_shortest_path(a, f);
   graph.bellman_ford(a);
+
+  LG::QueryContext<T, C> ctx;
+  if (graph.singular_shortest_path(a, f, ctx))
+    std::cout << ctx.distance(f) << std::endl;
+  print_node(graph.template explore_bfs<LG::VisitOrder::pre>(a, ctx));
+
+  LG::DiGraph<N, LG::Unweighted, T, std::unordered_map<int, int>> hops;
+  auto h0 = hops.registerNode(0);
+  auto h1 = hops.registerNode(1);
+  auto h2 = hops.registerNode(2);
+  auto h3 = hops.registerNode(3);
+  hops.registerEdge({h0, h1, {}});
+  hops.registerEdge({h1, h2, {}});
+  hops.registerEdge({h0, h2, {}});
+  hops.registerEdge({h2, h3, {}});
+  auto [hop_dist, hop_prev] = hops.singular_shortest_path(h0, h3);
+  std::cout << (hop_dist[h3] == 2 ? "True" : "False") << std::endl;
+  std::cout << (hops.bellman_ford(h0).first.at(h3) == 2 ? "True" : "False")
+            << std::endl;
+
+  // two components {0, 1, 2} and {3, 4}, a spanning forest keeps 3 edges
+  LG::UniGraph<N, LG::Unweighted, T> forest;
+  forest.registerEdge({0, 1, {}});
+  forest.registerEdge({1, 2, {}});
+  forest.registerEdge({0, 2, {}});
+  forest.registerEdge({3, 4, {}});
+  std::cout << (forest.mst_kruskal().size() == 3 ? "True" : "False")
+            << std::endl;
+
   auto dfs_pre = graph.template explore_dfs<LG::VisitOrder::pre>(a);
   auto dfs_post = graph.template explore_dfs<LG::VisitOrder::post>(a);
   print_node(dfs_pre);
@@ -54,9 +88,53 @@ template <class N, class C, class T> void make_graph() {
   /*print_node(dfs_post);*/
 }
 
+template <class T, class C> bool make_external_graph() {
+  // two components {0, 1, 2, 3, 4} and {5, 6}, edges in source order
+  const std::vector<LG::CounterEdge<T, C>> edges = {
+      {0, 1, 1}, {1, 2, 1}, {2, 3, 1}, {3, 4, 1}, {5, 6, 1}};
+  const auto path =
+      (std::filesystem::temp_directory_path() / "lean_graph_main_edges.bin")
+          .string();
+
+  auto writer = LG::ExternalEdgeWriter<T, C>::create(path, 2);
+  if (not writer)
+    return false;
+  for (auto &edge : edges)
+    if (writer->append(edge).has_value())
+      return false;
+  if (writer->finish().has_value())
+    return false;
+
+  bool ok = [&] {
+    auto external = LG::ExternalDiGraph<T, C>::open(path);
+    if (not external)
+      return false;
+
+    auto order = external->explore_bfs(0);
+    auto conn = external->connectivity();
+    LG::QueryContext<T, C> ctx;
+    auto relaxed = external->bellman_ford(0, ctx);
+    if (not order or not conn or not relaxed)
+      return false;
+
+    auto &stats = external->stats();
+    std::cout << stats.passes << " passes, " << stats.bytes_read
+              << " bytes, " << stats.edges_per_second() << " edges/s"
+              << std::endl;
+    return order->size() == 5 and conn->is_connected(0, 4) and
+           not conn->is_connected(0, 5) and *relaxed and
+           ctx.distance(4) == 4 and not ctx.reached(5);
+  }();
+
+  std::filesystem::remove(path);
+  return ok;
+}
+
 int main() {
 
   make_graph<uint32_t, uint32_t, uint32_t>();
+  std::cout << (make_external_graph<uint32_t, uint32_t>() ? "True" : "False")
+            << std::endl;
   /*make_graph<uint32_t, uint16_t, uint16_t>();*/
 
   return 0;